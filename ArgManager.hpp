@@ -7,21 +7,31 @@
 #include <vector>
 
 #include "Arguments.hpp"
+#include "FieldList.hpp"
+#include "LineRange.hpp"
+#include "Regex.hpp"
+
+namespace xcut {
 
 class ArgManager {
 public:
-    ArgManager();
+    ArgManager(bool print_errors = true);
     bool processArgs(int argc, char **argv);
     Arguments getArgs() const;
     void showHelp() const;
     bool isHelpRequested() const;
+    std::string getError() const;
 
 private:
     Arguments m_args;
     bool m_status_ok = true;
+    bool m_print_errors;
+    std::string m_error;
+    unsigned m_file_count = 0u;
     enum class State {inv, arg, val, file};
-    const std::vector<std::string> m_unary = {"-h", "-i", "-s"};
-    const std::vector<std::string> m_binary = {"-d", "-f", "-p", "-x"};
+    const std::vector<std::string> m_unary = {"-h", "-i", "-q", "-s", "-v", "-z", "--follow", "--index", "--stats"};
+    const std::vector<std::string> m_binary = {"-b", "-c", "-d", "-f", "-g", "-G", "-m", "-p", "-x", "--lines", "--max-delay"};
+    const unsigned long m_max_cache_slots = 1u << 20;   // allocated up front per processor
     void addFile(const std::string& file_name);
     bool is_file(const std::string& path) const;
     bool is_dir (const std::string& path) const;
@@ -31,22 +41,34 @@ private:
     bool isBinaryArgument(const std::string& option) const;
     void flagError(const std::string& msg);
     void validate();
-    bool validateList(const std::string& list) const;
     std::vector<std::string> splitRegex(const std::string& arg_val) const;
 };
 
-ArgManager::ArgManager()
+ArgManager::ArgManager(bool print_errors) : m_print_errors(print_errors)
 {
     // Set default arg values
     m_args.set("-h", "0");
     m_args.set("-i", "0");
+    m_args.set("-q", "0");
     m_args.set("-s", "0");
+    m_args.set("-v", "0");
+    m_args.set("-z", "0");
+    m_args.set("-b", "");
+    m_args.set("-c", "");
     m_args.set("-d", " ");
     m_args.set("-f", "");
+    m_args.set("-g", "");
+    m_args.set("-G", "");
+    m_args.set("-m", "auto");
     m_args.set("-p", "");
     m_args.set("-x", "");
     m_args.set("-xs", "");
     m_args.set("-xr", "");
+    m_args.set("--follow", "0");
+    m_args.set("--index", "0");
+    m_args.set("--lines", "");
+    m_args.set("--max-delay", "200");
+    m_args.set("--stats", "0");
 }
 
 bool ArgManager::processArgs(int argc, char **argv)
@@ -96,8 +118,7 @@ bool ArgManager::processArgs(int argc, char **argv)
 
 void ArgManager::addFile(const std::string& file_name)
 {
-    static auto file_count = 0u;
-    auto name = "file" + std::to_string(file_count++);
+    auto name = "file" + std::to_string(m_file_count++);
     m_args.set(name, file_name);
 }
 
@@ -118,7 +139,10 @@ bool ArgManager::isBinaryArgument(const std::string& option) const
 
 void ArgManager::flagError(const std::string& msg)
 {
-    std::cerr << "xcut: " << msg << "\n" << std::endl;
+    if (m_print_errors) {
+        std::cerr << "xcut: " << msg << "\n" << std::endl;
+    }
+    m_error = msg;
     m_status_ok = false;
 }
 
@@ -126,12 +150,40 @@ void ArgManager::validate()
 {
     if (m_args.get("-d") == "") {
         flagError("Option -d does not accept empty value.");
-    } else if (!validateList(m_args.get("-f"))) {
-        flagError("Option -f expects a comma separated list of integers");
-    } else if (!validateList(m_args.get("-p"))) {
-        flagError("Option -p expects a comma separated list of integers");
+    } else if (!FieldList::validate(m_args.get("-b"))) {
+        flagError("Option -b expects a comma separated list of ranges N, N-M, N- or -M");
+    } else if (!FieldList::validate(m_args.get("-c"))) {
+        flagError("Option -c expects a comma separated list of ranges N, N-M, N- or -M");
+    } else if (m_args.get("-b") != "" && m_args.get("-c") != "") {
+        flagError("Options -b and -c cannot be used together.");
+    } else if (m_args.get("-q") == "1" && m_args.get("-d").size() != 1) {
+        flagError("Option -q requires a single character delimiter.");
+    } else if (m_args.get("-q") == "1" && (m_args.get("-b") != "" || m_args.get("-c") != "")) {
+        flagError("Option -q cannot be used with options -b or -c.");
+    } else if (!FieldList::validate(m_args.get("-f"))) {
+        flagError("Option -f expects a comma separated list of fields N, N-M, N- or -M");
+    } else if (!FieldList::validate(m_args.get("-p"))) {
+        flagError("Option -p expects a comma separated list of fields N, N-M, N- or -M");
+    } else if (!std::regex_match(m_args.get("--max-delay"), std::regex("^\\d{1,9}$"))) {
+        flagError("Option --max-delay expects a number of milliseconds");
+    } else if (!std::regex_match(m_args.get("-m"), std::regex("^(auto|\\d{1,7})$"))) {
+        flagError("Option -m expects a number of cache slots or 'auto'");
+    } else if (m_args.get("-m") != "auto" && std::stoul(m_args.get("-m")) > m_max_cache_slots) {
+        flagError("Option -m accepts at most " + std::to_string(m_max_cache_slots) + " cache slots");
+    } else if (!LineRange::validate(m_args.get("--lines"))) {
+        flagError("Option --lines expects a single range of lines N, N-M, N- or -M");
+    } else if (m_args.get("--follow") == "1" && (m_args.get("--lines") != "" || m_args.get("--index") == "1")) {
+        flagError("Option --follow cannot be used with options --lines or --index.");
+    } else if (m_args.get("--index") == "1" && m_args.get("-q") == "1") {
+        flagError("Option --index cannot be used with option -q.");
     } else if (m_args.get("-x") != "" && m_args.get("-xs") == "") {
         flagError("Search pattern '" + m_args.get("-x") + "' in option -x cannot be empty.");
+    } else if (!isRegex(m_args.get("-g"))) {
+        flagError("Pattern '" + m_args.get("-g") + "' in option -g is not a valid regular expression.");
+    } else if (!std::regex_match(m_args.get("-G"), std::regex("^([1-9]\\d{0,8})?$"))) {
+        flagError("Option -G expects a single field number");
+    } else if ((m_args.get("-G") != "" || m_args.get("-v") == "1") && m_args.get("-g") == "") {
+        flagError("Options -G and -v require option -g with non-empty value.");
     } else if (m_args.get("-i") == "1" && m_args.get("-p") == "") {
         flagError("Option -i requires option -p with non-empty value.");
     } else if (m_args.get("-p") != "" && m_args.get("-x") == "") {
@@ -161,10 +213,9 @@ bool ArgManager::is_dir(const std::string& path) const
     return S_ISDIR(buf.st_mode);
 }
 
-bool ArgManager::validateList(const std::string& list) const
+std::string ArgManager::getError() const
 {
-    auto regex    = std::regex("^[1-9]\\d*(,[1-9]\\d*)*$");
-    return (list == "" || std::regex_match(list, regex));
+    return m_error;
 }
 
 bool ArgManager::isHelpRequested() const
@@ -191,12 +242,36 @@ void ArgManager::showHelp() const
     out << "Example: xcut -f 1,2 -x 's/\\d/<num>/' < file.txt\n\n";
 
     out << "Options\n";
-    out << "  -d DELIM    Use DELIM instead of SPACE for field delimiter.\n";
-    out << "  -f FIELDS   Comma separated list of fiels to print (1-index base).\n";
+    out << "  -b RANGES   Split lines in fixed-width fields, one per comma separated\n";
+    out << "              byte range N, N-M, N- or -M (1-index base).\n";
+    out << "  -c RANGES   Same as -b, but ranges count UTF-8 characters.\n";
+    out << "  -d DELIM    Use DELIM instead of SPACE for field delimiter. When used with\n";
+    out << "              -b or -c, DELIM is only used to join output fields.\n";
+    out << "  -f FIELDS   Comma separated list of fiels to print (1-index base). Fields\n";
+    out << "              can be ranges N-M, N- or -M, and be reordered or repeated.\n";
     out << "  -p FIELDS   Comma separated list of fiels to apply PATTERN to. (1-index base)\n";
     out << "  -x PATTERN  sed like Regular Expression to be applied on all or specified parts.\n";
+    out << "  -g REGEX    Only process lines matching REGEX, like grep.\n";
+    out << "  -G FIELD    Match REGEX of option -g against FIELD only.\n";
+    out << "  -v          Only process lines not matching REGEX of option -g.\n";
     out << "  -i          Apply PATTERN to inversed -p list\n";
+    out << "  -m SLOTS    Cache PATTERN results for up to SLOTS distinct field values per\n";
+    out << "              thread, at most 1048576. 0 disables the cache. By default (auto)\n";
+    out << "              a 4096 slot cache is used while its hit rate is high enough.\n";
+    out << "  -q          Parse lines as CSV, where fields in double quotes can contain\n";
+    out << "              DELIM, line breaks and escaped quotes (\"\"). Records may end in\n";
+    out << "              CRLF. Output fields are quoted as needed.\n";
     out << "  -s          Output lines sorted in the original order.\n";
+    out << "  -z          Compress output with gzip.\n";
+    out << "  --follow    Keep reading data appended to FILEs, following rotations.\n";
+    out << "  --lines RANGE\n";
+    out << "              Only process lines in RANGE (N, N-M, N- or -M) of each input.\n";
+    out << "  --index     Use FILE.xcutidx to seek to the first line of --lines, and\n";
+    out << "              create or refresh it when FILE has changed.\n";
+    out << "  --stats     Print replace cache statistics to standard error.\n";
+    out << "  --max-delay MS\n";
+    out << "              Longest time in milliseconds output is buffered in --follow\n";
+    out << "              mode (default 200).\n";
     out << "  -h          This help\n";
 
     out << "\nAll options are optional, except in these cases:\n";
@@ -207,7 +282,7 @@ void ArgManager::showHelp() const
 
 std::vector<std::string> ArgManager::splitRegex(const std::string& arg_val) const
 {
-    static const std::regex match_re("s/(.*)/(.*)/");
+    const std::regex match_re("s/(.*)/(.*)/");
 
     std::string search;
     std::string replace;
@@ -230,4 +305,6 @@ std::vector<std::string> ArgManager::splitRegex(const std::string& arg_val) cons
     return std::vector<std::string>({search, replace});
 }
 
+} // namespace xcut
+
 #endif //JM_ARG_MANAGER_HPP
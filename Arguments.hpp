@@ -4,6 +4,8 @@
 #include <unordered_map>
 #include <vector>
 
+namespace xcut {
+
 class Arguments {
 private:
     std::unordered_map<std::string, std::string> m_args;
@@ -42,4 +44,6 @@ bool Arguments::exists(const std::string& name) const
     return m_args.count(name) > 0;
 }
 
+} // namespace xcut
+
 #endif //JM_ARGUMENTS_HPP
@@ -0,0 +1,53 @@
+#ifndef JM_COMPRESSOR_HPP
+#define JM_COMPRESSOR_HPP
+
+#include <stdexcept>
+#include <string>
+#include <zlib.h>
+
+namespace xcut {
+
+// Compresses blocks of output into independent gzip members. Concatenated
+// members form a valid gzip stream, so blocks can be compressed in parallel
+// and written in order.
+class Compressor {
+public:
+    static std::string gzip(const std::string& data, int level = Z_DEFAULT_COMPRESSION);
+
+private:
+    Compressor() = delete;
+};
+
+std::string Compressor::gzip(const std::string& data, int level)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree  = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    // windowBits + 16 makes zlib write a gzip header and trailer
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("xcut: cannot initialise compressor.");
+    }
+
+    auto member = std::string(deflateBound(&stream, data.size()), '\0');
+
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in  = data.size();
+    stream.next_out  = reinterpret_cast<Bytef*>(&member[0]);
+    stream.avail_out = member.size();
+
+    auto result = deflate(&stream, Z_FINISH);
+    member.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error("xcut: cannot compress output.");
+    }
+
+    return member;
+}
+
+} // namespace xcut
+
+#endif //JM_COMPRESSOR_HPP
@@ -1,52 +1,80 @@
 #ifndef JM_DATA_PROCESSOR_HPP
 #define JM_DATA_PROCESSOR_HPP
 
+#include <sstream>
+
 #include "DataQueue.hpp"
 #include "Line.hpp"
+#include "LineConfig.hpp"
+#include "ReplaceCache.hpp"
 #include "Worker.hpp"
 
+namespace xcut {
+
 class DataProcessor : public Worker {
 public:
-    DataProcessor(const Arguments& args, DataQueue& queue_in, DataQueue& queue_out);
+    DataProcessor(const Arguments& args, const LineConfig& config, DataQueue& queue_in, DataQueue& queue_out);
 
 private:
     DataQueue& m_queue_in;
     DataQueue& m_queue_out;
+    const LineConfig& m_config;
+    ReplaceCache m_cache;
 
 private:
     DataProcessor() = delete;
     void doJob();
-    void processLine();
+    bool processLine();
+    void printStats() const;
 };
 
-DataProcessor::DataProcessor(const Arguments& args, DataQueue& queue_in, DataQueue& queue_out) :
-    Worker(args), m_queue_in(queue_in), m_queue_out(queue_out)
+DataProcessor::DataProcessor(const Arguments& args, const LineConfig& config, DataQueue& queue_in, DataQueue& queue_out) :
+    Worker(args), m_queue_in(queue_in), m_queue_out(queue_out), m_config(config),
+    m_cache(args)
 {
 }
 
 void DataProcessor::doJob()
 {
     while (!m_done) {
-        processLine();
+        auto count_in = m_queue_in.getCountIn();
+        if (!processLine()) {
+            m_queue_in.waitForPush(count_in, m_idle_wait);
+        }
 
         if (m_status == Status::processing && m_queue_in.getCountIn() == m_queue_out.getCountIn()) {
             m_done = true;
         }
     }
 
+    if (m_args.get("--stats") == "1") {
+        printStats();
+    }
+
     return;
 }
 
-void DataProcessor::processLine()
+bool DataProcessor::processLine()
 {
     auto line = m_queue_in.pullNext();
 
     if (!line.isEmpty()) {
-        line.process(m_args);
+        line.process(m_config, m_cache);
         m_queue_out.push(line);
     }
 
-    return;
+    return !line.isEmpty();
 }
 
+void DataProcessor::printStats() const
+{
+    // Built first so lines from concurrent processors do not interleave
+    std::ostringstream stats;
+    stats << "xcut: replace cache " << (m_cache.isEnabled() ? "on" : "off")
+          << ", hits " << m_cache.getHits() << ", misses " << m_cache.getMisses() << "\n";
+    std::cerr << stats.str() << std::flush;
+}
+
+} // namespace xcut
+
 #endif //JM_DATA_PROCESSOR_HPP
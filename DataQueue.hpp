@@ -2,11 +2,15 @@
 #define JM_LINE_QUEUE_HPP
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <unordered_map>
 
 #include "Line.hpp"
 
+namespace xcut {
+
 class DataQueue {
 public:
     void        push(const Line& line);
@@ -16,10 +20,12 @@ public:
     bool        exists(unsigned key);
     unsigned    getCountIn() const;
     unsigned    getCountOut() const;
+    bool        waitForPush(unsigned count_in, const std::chrono::milliseconds& timeout);
 
 private:
     std::unordered_map<unsigned,Line> m_queue;
     std::mutex m_mtx_queue;
+    std::condition_variable m_cv_push;
     std::atomic<bool> m_eof{false};
     std::atomic<unsigned> m_count_in  {0u};
     std::atomic<unsigned> m_count_out {0u};
@@ -27,9 +33,12 @@ private:
 
 void DataQueue::push(const Line& line)
 {
-    std::lock_guard<std::mutex> guard(m_mtx_queue);
-    m_queue.insert({line.getNum(), line});
-    ++m_count_in;
+    {
+        std::lock_guard<std::mutex> guard(m_mtx_queue);
+        m_queue.insert({line.getNum(), line});
+        ++m_count_in;
+    }
+    m_cv_push.notify_one();
 
     return;
 }
@@ -73,6 +82,13 @@ unsigned DataQueue::getCountOut() const
     return m_count_out;
 }
 
+// Blocks until a line is pushed after the caller saw count_in lines pushed, or
+// until timeout expires. Lets idle workers sleep instead of spinning.
+bool DataQueue::waitForPush(unsigned count_in, const std::chrono::milliseconds& timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mtx_queue);
+    return m_cv_push.wait_for(lock, timeout, [&](){return m_count_in != count_in;});
+}
 
 unsigned DataQueue::size()
 {
@@ -86,4 +102,6 @@ bool DataQueue::exists(unsigned key)
     return m_queue.count(key) > 0;
 }
 
+} // namespace xcut
+
 #endif //JM_LINE_QUEUE_HPP
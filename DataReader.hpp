@@ -4,9 +4,21 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "DataQueue.hpp"
+#include "LineAssembler.hpp"
+#include "LineFilter.hpp"
+#include "LineIndex.hpp"
+#include "LineRange.hpp"
 #include "Worker.hpp"
 
+namespace xcut {
+
 class DataReader : public Worker {
 public:
     DataReader(const Arguments& args, DataQueue& queue);
@@ -14,15 +26,45 @@ public:
 private:
     DataQueue& m_queue;
     std::vector<std::string> m_files;
+    LineAssembler m_assembler;
+    const LineFilter m_filter;
+    unsigned m_line_count = 0u;
+    const bool m_use_index;
+    const std::uint64_t m_first_line;
+    const std::uint64_t m_last_line;
+
+    // State of a file being followed in --follow mode
+    struct FollowedFile {
+        FollowedFile(const std::string& file_name, const Arguments& args) :
+            name(file_name), assembler(args) {}
+
+        std::string name;
+        int   fd     = -1;
+        int   watch  = -1;
+        ino_t inode  = 0;
+        off_t offset = 0;
+        LineAssembler assembler;
+    };
 
 private:
     void doJob();
     DataReader() = delete;
-    void readFromStream(std::istream& in);
+    void readFromStream(std::istream& in, std::uint64_t line_num = 1u);
+    void readFromFile(const std::string& file);
+    bool isLineStart(std::istream& in, std::uint64_t offset) const;
+    void followFiles();
+    void openFollowed(int notify_fd, FollowedFile& file);
+    void closeFollowed(int notify_fd, FollowedFile& file);
+    void checkFollowed(int notify_fd, FollowedFile& file);
+    void readFollowed(FollowedFile& file);
+    void pushLine(std::string& value);
 };
 
 DataReader::DataReader(const Arguments& args, DataQueue& queue) :
-    Worker(args), m_queue(queue)
+    Worker(args), m_queue(queue), m_assembler(args), m_filter(args),
+    m_use_index(args.get("--index") == "1"),
+    m_first_line(LineRange(args.get("--lines")).getFirst()),
+    m_last_line(LineRange(args.get("--lines")).getLast())
 {
     m_files = m_args.find_all_matching("file");
 }
@@ -32,25 +74,212 @@ void DataReader::doJob()
     if (m_files.empty()) {
         std::istream& in = std::cin;
         readFromStream(in);
+    } else if (m_args.get("--follow") == "1") {
+        followFiles();
     } else {
         for (auto& file : m_files) {
-            std::ifstream in (file, std::ifstream::in);
-            readFromStream(in);
-            in.close();
+            readFromFile(file);
         }
     }
     m_done = true;
 }
 
-void DataReader::readFromStream(std::istream& in)
+// With --index, seeks to the indexed line closest to the first line in
+// --lines, building the index first if it is missing or stale. An index whose
+// offset is not right after a line break is rebuilt, and if the file keeps
+// changing it is read from the start instead.
+void DataReader::readFromFile(const std::string& file)
+{
+    std::ifstream in (file, std::ifstream::in);
+    auto line_num = std::uint64_t(1);
+
+    if (m_use_index) {
+        auto index = LineIndex(file);
+        if (index.load() || index.build()) {
+            auto offset = index.findOffset(m_first_line, line_num);
+            if (!isLineStart(in, offset) && index.build()) {
+                offset = index.findOffset(m_first_line, line_num);
+            }
+            if (!isLineStart(in, offset)) {
+                offset = 0u;
+                line_num = 1u;
+            } else if (m_first_line > index.getLineCount()) {
+                return;
+            }
+            in.seekg(offset);
+        }
+    }
+
+    readFromStream(in, line_num);
+    in.close();
+
+    return;
+}
+
+bool DataReader::isLineStart(std::istream& in, std::uint64_t offset) const
+{
+    if (offset == 0) {
+        return true;
+    }
+
+    auto c = char(0);
+    in.seekg(offset - 1);
+    in.get(c);
+    auto line_start = in && c == '\n';
+    in.clear();
+
+    return line_start;
+}
+
+// Reads lines from the stream, which is at line line_num (1-index based), and
+// pushes the ones in the --lines range. Reading stops after the range.
+void DataReader::readFromStream(std::istream& in, std::uint64_t line_num)
 {
     auto line_value = std::string();
-    while(std::getline(in, line_value)) {
-        auto line = Line(line_value);
-        m_queue.push(Line(line));
+    auto push = [this, &line_num](std::string& line) {
+        if (line_num++ >= m_first_line) {
+            pushLine(line);
+        }
+    };
+
+    while((m_last_line == 0 || line_num <= m_last_line) && std::getline(in, line_value)) {
+        m_assembler.addLine(line_value, push);
+    }
+    m_assembler.finish(push);
+
+    return;
+}
+
+// Reads appended data from all files forever. inotify events only wake the
+// reader up; every file is then re-checked by path, which also catches
+// rotations and truncations that happen while no watch is active.
+void DataReader::followFiles()
+{
+    auto notify_fd = inotify_init1(IN_CLOEXEC);
+    if (notify_fd < 0) {
+        std::cerr << "xcut: cannot watch files for changes." << std::endl;
+        return;
+    }
+
+    auto files = std::vector<FollowedFile>();
+    files.reserve(m_files.size());
+    for (const auto& name : m_files) {
+        files.emplace_back(name, m_args);
+        openFollowed(notify_fd, files.back());
+    }
+
+    char events[4096];
+    while (true) {
+        struct pollfd pfd = {notify_fd, POLLIN, 0};
+
+        // Wake up periodically to reopen files that have not been recreated yet
+        if (poll(&pfd, 1, 1000) > 0) {
+            if (read(notify_fd, events, sizeof(events)) < 0) {
+                break;
+            }
+        }
+
+        for (auto& file : files) {
+            checkFollowed(notify_fd, file);
+        }
+    }
+
+    for (auto& file : files) {
+        closeFollowed(notify_fd, file);
+    }
+    close(notify_fd);
+
+    return;
+}
+
+void DataReader::openFollowed(int notify_fd, FollowedFile& file)
+{
+    file.fd = open(file.name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file.fd < 0) {
+        return;
+    }
+
+    struct stat buf;
+    fstat(file.fd, &buf);
+    file.inode  = buf.st_ino;
+    file.offset = 0;
+    file.watch  = inotify_add_watch(notify_fd, file.name.c_str(),
+        IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+
+    readFollowed(file);
+
+    return;
+}
+
+void DataReader::closeFollowed(int notify_fd, FollowedFile& file)
+{
+    if (file.fd < 0) {
+        return;
     }
 
+    // A rotated file will not be appended to, so its last line is complete
+    file.assembler.finish([this](std::string& line) { pushLine(line); });
+
+    inotify_rm_watch(notify_fd, file.watch);
+    close(file.fd);
+    file.fd = -1;
+    file.watch = -1;
+
     return;
 }
 
+void DataReader::checkFollowed(int notify_fd, FollowedFile& file)
+{
+    if (file.fd < 0) {
+        openFollowed(notify_fd, file);
+        return;
+    }
+
+    struct stat buf;
+    fstat(file.fd, &buf);
+    if (buf.st_size < file.offset) {
+        // Truncated in place: start again from the beginning
+        lseek(file.fd, 0, SEEK_SET);
+        file.offset = 0;
+        file.assembler.clear();
+    }
+
+    readFollowed(file);
+
+    if (stat(file.name.c_str(), &buf) == 0 && buf.st_ino != file.inode) {
+        // Rotated: the old file has been drained, switch to the new one. Until
+        // the new file shows up, keep reading the old one in case it is still
+        // being written to.
+        closeFollowed(notify_fd, file);
+        openFollowed(notify_fd, file);
+    }
+
+    return;
+}
+
+void DataReader::readFollowed(FollowedFile& file)
+{
+    char buffer[65536];
+    auto count = ssize_t(0);
+
+    while ((count = read(file.fd, buffer, sizeof(buffer))) > 0) {
+        file.offset += count;
+        file.assembler.add(buffer, count, [this](std::string& line) { pushLine(line); });
+    }
+
+    return;
+}
+
+// Moves value into the queued line, so it is left unspecified
+void DataReader::pushLine(std::string& value)
+{
+    if (m_filter.accept(value)) {
+        m_queue.push(Line(std::move(value), ++m_line_count));
+    }
+
+    return;
+}
+
+} // namespace xcut
+
 #endif //JM_DATA_READER_HPP
@@ -1,65 +1,248 @@
 #ifndef JM_DATA_WRITER_HPP
 #define JM_DATA_WRITER_HPP
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
 #include "ArgManager.hpp"
+#include "Compressor.hpp"
 #include "DataQueue.hpp"
 #include "Worker.hpp"
 
+namespace xcut {
+
 class DataWriter : public Worker {
 public:
     DataWriter(const Arguments& args, DataQueue& queue);
 
 private:
     DataQueue& m_queue;
+    const bool m_sorted;
+    unsigned m_next_line = 1u;
+    const bool m_compress;
+    const bool m_follow;
+    const std::chrono::milliseconds m_max_delay;
+    std::chrono::steady_clock::time_point m_last_flush;
+    bool m_unflushed = false;
+    const unsigned m_max_pending;
+    const std::size_t m_block_size = 1u << 20;
+    std::string m_block;
+    std::deque<std::future<std::string>> m_pending;
+
+    // Compression threads, as many as there are processors, started with the
+    // writer and fed blocks through m_tasks.
+    const unsigned m_num_compressors;
+    std::vector<std::thread> m_compressors;
+    std::deque<std::packaged_task<std::string()>> m_tasks;
+    std::mutex m_mtx_tasks;
+    std::condition_variable m_cv_tasks;
+    bool m_stop_compressors = false;
 
 private:
     DataWriter() = delete;
     void doJob();
-    void printOutputSorted();
-    void printOutputUnsorted();
+    bool printOutputSorted();
+    bool printOutputUnsorted();
+    void write(const std::string& value);
+    void flush();
+    void compressBlock();
+    void writePending(std::size_t max_pending);
+    void startCompressors();
+    void stopCompressors();
+    void runCompressor();
 };
 
 DataWriter::DataWriter(const Arguments& args, DataQueue& queue) :
-    Worker(args), m_queue(queue)
+    Worker(args), m_queue(queue),
+    m_sorted(args.get("-s") == "1"),
+    m_compress(args.get("-z") == "1"),
+    m_follow(args.get("--follow") == "1"),
+    m_max_delay(std::stoul(args.get("--max-delay"))),
+    m_last_flush(std::chrono::steady_clock::now()),
+    m_max_pending(std::max(std::thread::hardware_concurrency(), 1u)),
+    m_num_compressors(std::max(std::thread::hardware_concurrency(), 3u) - 2)
 {
 }
 
 void DataWriter::doJob()
 {
+    startCompressors();
+
     while (m_status != Status::writing || m_queue.size() > 0) {
-        if (m_args.get("-s") == "1") {
-            printOutputSorted();
+        auto count_in = m_queue.getCountIn();
+        auto written = false;
+        if (m_sorted) {
+            written = printOutputSorted();
         } else {
-            printOutputUnsorted();
+            written = printOutputUnsorted();
+        }
+
+        if (!written) {
+            // In follow mode, whatever is buffered goes out as soon as input
+            // stalls, so latency is only bounded by m_max_delay under load.
+            if (m_follow && m_unflushed) {
+                flush();
+            }
+            m_queue.waitForPush(count_in, m_idle_wait);
+        } else if (m_follow && std::chrono::steady_clock::now() - m_last_flush >= m_max_delay) {
+            flush();
         }
     }
 
+    flush();
+    stopCompressors();
+
     m_done = true;
 
     return;
 }
 
-void DataWriter::printOutputSorted()
+bool DataWriter::printOutputSorted()
 {
-    static auto line_num = 1u;
-    auto line = m_queue.pull(line_num);
+    auto line = m_queue.pull(m_next_line);
     if (!line.isEmpty()) {
-        ++line_num;
-        std::cout << line.getValue() << "\n";
+        ++m_next_line;
+        write(line.getValue());
     }
 
-    return;
+    return !line.isEmpty();
 }
 
-void DataWriter::printOutputUnsorted()
+bool DataWriter::printOutputUnsorted()
 {
     auto line = m_queue.pullNext();
 
     if (!line.isEmpty()) {
-        std::cout << line.getValue() << "\n";
+        write(line.getValue());
+    }
+
+    return !line.isEmpty();
+}
+
+void DataWriter::write(const std::string& value)
+{
+    m_unflushed = true;
+    if (m_failed) {
+        return;
+    } else if (!m_compress) {
+        std::cout << value << "\n";
+        return;
+    }
+
+    m_block += value;
+    m_block += "\n";
+    if (m_block.size() >= m_block_size) {
+        compressBlock();
+        writePending(m_max_pending);
     }
 
     return;
 }
 
+void DataWriter::flush()
+{
+    if (m_compress && !m_failed) {
+        compressBlock();
+        writePending(0);
+    }
+    std::cout << std::flush;
+
+    m_unflushed = false;
+    m_last_flush = std::chrono::steady_clock::now();
+
+    return;
+}
+
+void DataWriter::compressBlock()
+{
+    if (!m_block.empty()) {
+        auto block = std::string();
+        block.swap(m_block);
+        auto task = std::packaged_task<std::string()>(std::bind(&Compressor::gzip, std::move(block), Z_DEFAULT_COMPRESSION));
+        m_pending.push_back(task.get_future());
+
+        std::lock_guard<std::mutex> guard(m_mtx_tasks);
+        m_tasks.push_back(std::move(task));
+        m_cv_tasks.notify_one();
+    }
+
+    return;
+}
+
+// If a block cannot be compressed, the output is cut short there: the error is
+// reported once and the remaining lines are drained without being written, so
+// the other workers can finish.
+void DataWriter::writePending(std::size_t max_pending)
+{
+    // Members are written in the order their blocks were filled
+    while (!m_failed && m_pending.size() > max_pending) {
+        auto member = std::string();
+        try {
+            member = m_pending.front().get();
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << std::endl;
+            m_failed = true;
+            m_pending.clear();
+            break;
+        }
+        m_pending.pop_front();
+        std::cout.write(member.data(), member.size());
+    }
+
+    return;
+}
+
+void DataWriter::startCompressors()
+{
+    if (m_compress) {
+        for (auto i = 0u; i<m_num_compressors; ++i) {
+            m_compressors.push_back(std::thread(&DataWriter::runCompressor, this));
+        }
+    }
+
+    return;
+}
+
+void DataWriter::stopCompressors()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mtx_tasks);
+        m_stop_compressors = true;
+        m_cv_tasks.notify_all();
+    }
+
+    for (auto& compressor : m_compressors) {
+        compressor.join();
+    }
+    m_compressors.clear();
+
+    return;
+}
+
+void DataWriter::runCompressor()
+{
+    while (true) {
+        auto task = std::packaged_task<std::string()>();
+        {
+            std::unique_lock<std::mutex> lock(m_mtx_tasks);
+            m_cv_tasks.wait(lock, [this](){return m_stop_compressors || !m_tasks.empty();});
+            if (m_tasks.empty()) {
+                break;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        // Exceptions are stored in the task's future, and caught by writePending()
+        task();
+    }
+
+    return;
+}
+
+} // namespace xcut
+
 #endif //JM_DATA_WRITER_HPP
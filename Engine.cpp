@@ -0,0 +1,197 @@
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "Engine.hpp"
+#include "ArgManager.hpp"
+#include "Line.hpp"
+#include "LineAssembler.hpp"
+#include "LineConfig.hpp"
+#include "LineFilter.hpp"
+#include "ReplaceCache.hpp"
+
+namespace xcut {
+
+struct Engine::Impl {
+    Impl(const Arguments& args, Executor executor, unsigned num_batches);
+    void addInput(const char* data, std::size_t size);
+    void addLine(std::string& line);
+    void processLines();
+    void processBatch(unsigned batch, std::size_t begin, std::size_t end);
+
+    const LineConfig m_config;
+    const LineFilter m_filter;
+    LineAssembler m_assembler;
+    Executor m_executor;
+    const std::size_t m_min_batch_size = 256u;
+
+    // Each batch has its own cache and output, so batches need no locking
+    std::vector<ReplaceCache> m_caches;
+    std::vector<std::string>  m_outputs;
+    std::vector<std::string>  m_lines;
+    std::string m_output;
+    unsigned m_line_count = 0u;
+
+    std::mutex m_mtx_pending;
+    std::condition_variable m_cv_pending;
+    unsigned m_pending = 0u;
+    std::exception_ptr m_error;
+};
+
+Engine::Impl::Impl(const Arguments& args, Executor executor, unsigned num_batches) :
+    m_config(args),
+    m_filter(args),
+    m_assembler(args),
+    m_executor(executor)
+{
+    if (!m_executor || num_batches == 0) {
+        num_batches = m_executor ? std::max(std::thread::hardware_concurrency(), 1u) : 1u;
+    }
+
+    for (auto batch = 0u; batch<num_batches; ++batch) {
+        m_caches.emplace_back(args);
+    }
+    m_outputs.resize(num_batches);
+}
+
+void Engine::Impl::addInput(const char* data, std::size_t size)
+{
+    m_assembler.add(data, size, [this](std::string& line) { addLine(line); });
+}
+
+// Moves line into the pending lines, so it is left unspecified
+void Engine::Impl::addLine(std::string& line)
+{
+    if (m_filter.accept(line)) {
+        m_lines.push_back(std::move(line));
+    }
+}
+
+// Splits the pending lines in contiguous batches and appends their output in
+// order. Small inputs are not worth handing over to other threads.
+void Engine::Impl::processLines()
+{
+    m_output.clear();
+
+    auto num_batches = std::min<std::size_t>(m_caches.size(), m_lines.size() / m_min_batch_size);
+    if (!m_executor || num_batches <= 1) {
+        processBatch(0, 0, m_lines.size());
+        m_output.swap(m_outputs[0]);
+    } else {
+        m_pending = num_batches;
+        for (auto batch = 0u; batch<num_batches; ++batch) {
+            auto begin = m_lines.size() * batch / num_batches;
+            auto end   = m_lines.size() * (batch + 1) / num_batches;
+            m_executor([this, batch, begin, end]() {
+                auto error = std::exception_ptr();
+                try {
+                    processBatch(batch, begin, end);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> guard(m_mtx_pending);
+                m_error = error ? error : m_error;
+                if (--m_pending == 0) {
+                    m_cv_pending.notify_one();
+                }
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(m_mtx_pending);
+        m_cv_pending.wait(lock, [this](){return m_pending == 0;});
+        if (m_error) {
+            auto error = m_error;
+            m_error = std::exception_ptr();
+            m_lines.clear();
+            std::rethrow_exception(error);
+        }
+
+        for (auto batch = 0u; batch<num_batches; ++batch) {
+            m_output += m_outputs[batch];
+        }
+    }
+
+    m_line_count += m_lines.size();
+    m_lines.clear();
+}
+
+void Engine::Impl::processBatch(unsigned batch, std::size_t begin, std::size_t end)
+{
+    auto& output = m_outputs[batch];
+    output.clear();
+
+    for (auto i = begin; i<end; ++i) {
+        auto line = Line(std::move(m_lines[i]), m_line_count + i + 1);
+        line.process(m_config, m_caches[batch]);
+        output += line.getValue();
+        output += '\n';
+    }
+}
+
+Engine::Engine(const std::vector<std::string>& options, Executor executor, unsigned num_batches)
+{
+    auto argv = std::vector<char*>();
+    auto name = std::string("xcut");
+    argv.push_back(&name[0]);
+
+    auto values = options;
+    for (auto& value : values) {
+        argv.push_back(&value[0]);
+    }
+
+    auto arg_manager = ArgManager(false);
+    if (!arg_manager.processArgs(argv.size(), argv.data())) {
+        m_error = arg_manager.getError();
+    } else if (!arg_manager.getArgs().find_all_matching("file").empty()) {
+        m_error = "Engine does not read files: push their content instead.";
+    } else if (arg_manager.getArgs().get("--lines") != "" || arg_manager.getArgs().get("--index") == "1") {
+        m_error = "Engine does not support options --lines and --index: push only the lines to process.";
+    } else {
+        m_impl.reset(new Impl(arg_manager.getArgs(), executor, num_batches));
+    }
+}
+
+Engine::~Engine()
+{
+}
+
+bool Engine::isValid() const
+{
+    return m_impl != nullptr;
+}
+
+std::string Engine::getError() const
+{
+    return m_error;
+}
+
+const std::string& Engine::push(const char* data, std::size_t size)
+{
+    static const std::string no_output;
+    if (!m_impl) {
+        return no_output;
+    }
+
+    m_impl->addInput(data, size);
+    m_impl->processLines();
+
+    return m_impl->m_output;
+}
+
+const std::string& Engine::finish()
+{
+    static const std::string no_output;
+    if (!m_impl) {
+        return no_output;
+    }
+
+    m_impl->m_assembler.finish([this](std::string& line) { m_impl->addLine(line); });
+    m_impl->processLines();
+    m_impl->m_line_count = 0u;
+
+    return m_impl->m_output;
+}
+
+} // namespace xcut
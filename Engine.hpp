@@ -0,0 +1,57 @@
+#ifndef JM_ENGINE_HPP
+#define JM_ENGINE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xcut {
+
+// Embeddable xcut engine, built into libxcut.a and libxcut.so. Options are the
+// same as on the command line, for example {"-d", ",", "-f", "2-", "-x",
+// "s/\\d/N/"}. Input is pushed in buffers of any size. Output holds only
+// complete lines and keeps the input order.
+//
+// Lines are processed inline, or split into batches handed to an executor, so
+// callers can use their own thread pool. An engine must be used by one thread
+// at a time; separate engines are independent and can run concurrently.
+//
+// Options that control how xcut reads and writes (-s, -z, --follow,
+// --max-delay and --stats) have no effect. FILE arguments and the options
+// that select lines of a file (--lines and --index) are rejected.
+//
+// Only Engine is exported from libxcut.so; everything else stays internal.
+class __attribute__((visibility("default"))) Engine {
+public:
+    // Runs a task once, on any thread
+    typedef std::function<void(std::function<void()>)> Executor;
+
+    Engine(const std::vector<std::string>& options, Executor executor = Executor(), unsigned num_batches = 0);
+    ~Engine();
+    bool isValid() const;
+    std::string getError() const;
+
+    // Processes the complete lines in data, keeping any trailing partial line
+    // for the next call. The returned output is valid until the next call, and
+    // empty if the engine is not valid.
+    const std::string& push(const char* data, std::size_t size);
+
+    // Processes the trailing partial line, if any, and resets the engine. The
+    // output is empty if the engine is not valid.
+    const std::string& finish();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+    std::string m_error;
+
+private:
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+};
+
+} // namespace xcut
+
+#endif //JM_ENGINE_HPP
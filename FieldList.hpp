@@ -0,0 +1,150 @@
+#ifndef JM_FIELD_LIST_HPP
+#define JM_FIELD_LIST_HPP
+
+#include <algorithm>
+#include <climits>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace xcut {
+
+// List of 1-index based fields or columns given as comma separated N, N-M, N-
+// or -M. Ranges are kept in the given order, so a list can reorder and repeat
+// fields. A range ending in 0 is open-ended.
+class FieldList {
+public:
+    typedef std::vector<std::pair<unsigned, unsigned>> Ranges;
+
+    FieldList(const std::string& list);
+    bool empty() const;
+    bool contains(unsigned field) const;
+    const Ranges& ranges() const;
+    template <class Emit>
+    void forEach(unsigned num_fields, Emit emit) const;
+    static bool validate(const std::string& list);
+
+private:
+    Ranges m_ranges;
+    std::vector<bool> m_members;
+    unsigned m_open_from = 0u;
+    unsigned m_last_closed = 0u;
+    const unsigned m_max_table_size = 4096u;
+
+private:
+    static Ranges parse(const std::string& list);
+};
+
+FieldList::FieldList(const std::string& list) : m_ranges(parse(list))
+{
+    // Membership of the first fields is precomputed so that contains() does
+    // not scan the ranges. Fields beyond the table are rare enough to scan.
+    for (const auto& range : m_ranges) {
+        if (range.second == 0) {
+            m_open_from = (m_open_from == 0) ? range.first : std::min(m_open_from, range.first);
+        } else {
+            m_last_closed = std::max(m_last_closed, range.second);
+        }
+    }
+
+    m_members.resize(std::min(m_last_closed, m_max_table_size - 1) + 1u, false);
+    for (const auto& range : m_ranges) {
+        if (range.second != 0 && range.first < m_members.size()) {
+            auto last = std::min<std::size_t>(range.second, m_members.size() - 1);
+            std::fill(m_members.begin() + range.first, m_members.begin() + last + 1, true);
+        }
+    }
+}
+
+bool FieldList::empty() const
+{
+    return m_ranges.empty();
+}
+
+bool FieldList::contains(unsigned field) const
+{
+    if (m_open_from != 0 && field >= m_open_from) {
+        return true;
+    } else if (field < m_members.size()) {
+        return m_members[field];
+    } else if (field > m_last_closed) {
+        return false;
+    }
+
+    return std::any_of(m_ranges.begin(), m_ranges.end(), [field](const std::pair<unsigned, unsigned>& r) {
+        return r.first <= field && field <= r.second;
+    });
+}
+
+const FieldList::Ranges& FieldList::ranges() const
+{
+    return m_ranges;
+}
+
+// Calls emit with the 0-index based position of each listed field that exists
+// in a line with num_fields fields, in list order.
+template <class Emit>
+void FieldList::forEach(unsigned num_fields, Emit emit) const
+{
+    for (const auto& range : m_ranges) {
+        auto last = (range.second == 0) ? num_fields : std::min(range.second, num_fields);
+        for (auto field = range.first; field <= last; ++field) {
+            emit(field - 1);
+        }
+    }
+}
+
+bool FieldList::validate(const std::string& list)
+{
+    auto range = std::string("([1-9]\\d*(-([1-9]\\d*)?)?|-[1-9]\\d*)");
+    auto regex = std::regex("^" + range + "(," + range + ")*$");
+    if (list == "") {
+        return true;
+    } else if (!std::regex_match(list, regex)) {
+        return false;
+    }
+
+    // Numbers must fit in an unsigned before they are parsed
+    auto number = std::regex("\\d+");
+    auto numbers_begin = std::sregex_iterator(list.begin(), list.end(), number);
+    auto numbers_end   = std::sregex_iterator();
+    auto too_large = std::any_of(numbers_begin, numbers_end, [](const std::smatch& m) {
+        return m.length() > 10 || std::stoull(m.str()) > UINT_MAX;
+    });
+    if (too_large) {
+        return false;
+    }
+
+    auto ranges = parse(list);
+    return std::none_of(ranges.begin(), ranges.end(), [](const std::pair<unsigned, unsigned>& r) {
+        return r.second != 0 && r.second < r.first;
+    });
+}
+
+FieldList::Ranges FieldList::parse(const std::string& list)
+{
+    auto ranges = Ranges();
+
+    auto regex = std::regex(",");
+    auto begin = std::sregex_token_iterator(list.begin(), list.end(), regex, -1);
+    auto end   = std::sregex_token_iterator();
+    std::for_each(begin, end, [&](const std::string& m) {
+        if (m.empty()) {
+            return;
+        }
+        auto dash  = m.find('-');
+        auto first = (dash == 0) ? 1u : static_cast<unsigned>(std::stoul(m.substr(0, dash)));
+        auto last  = first;
+        if (dash != std::string::npos) {
+            last = (dash+1 < m.size()) ? static_cast<unsigned>(std::stoul(m.substr(dash+1))) : 0u;
+        }
+        ranges.push_back({first, last});
+    });
+
+    return ranges;
+}
+
+} // namespace xcut
+
+#endif //JM_FIELD_LIST_HPP
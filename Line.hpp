@@ -1,22 +1,28 @@
 #ifndef JM_LINE_HPP
 #define JM_LINE_HPP
 
+#include <iterator>
 #include <regex>
 #include <string>
 #include <vector>
 #include <iostream>
 
 #include "ArgManager.hpp"
+#include "FieldList.hpp"
+#include "LineConfig.hpp"
+#include "ReplaceCache.hpp"
+#include "Splitter.hpp"
+
+namespace xcut {
 
 typedef std::string str;
-typedef std::vector<unsigned> uvec;
 
 class Line {
 public:
     Line() {}
-    Line(const str& line);
-    void        process(const Arguments& args);
-    std::string join(const str& delimiter, const uvec& fields);
+    Line(str line, unsigned line_num);
+    void        process(const LineConfig& config, ReplaceCache& cache);
+    void        join(const str& delimiter, const FieldList& fields);
     std::string getValue() const;
     unsigned    getNum()   const;
     bool        isEmpty()  const;
@@ -24,37 +30,30 @@ public:
 private:
     std::string m_line   = std::string();
     std::string m_joined = std::string();
-    std::vector<str> m_parts;
+    Fields m_parts;
+    std::vector<str> m_owned;
     bool     m_empty     = true;
+    bool     m_quote     = false;
     unsigned m_line_num  = 0u;
 
 private:
-    void joinList(const str& delimiter, const uvec& fields);
+    void joinList(const str& delimiter, const FieldList& fields);
     void joinAll(const str& delimiter);
+    void appendPart(const str& delimiter, unsigned part_num);
     unsigned getNumParts() const;
-    void processPart(int part_num, const str& re_search, const str& re_replace);
-    void processPart(int part_num, const str& regex);
-    bool find(unsigned needle, const uvec& haystack) const;
-    void split(const str& delimiter);
-    std::vector<unsigned> splitFields(const std::string& arg_val) const;
+    const char* getPartData(unsigned part_num) const;
+    void processPart(int part_num, const LineConfig& config, ReplaceCache& cache);
+    void split(const Splitter& splitter);
 };
 
-Line::Line(const str& line) : m_line(line), m_empty(false)
+Line::Line(str line, unsigned line_num) :
+    m_line(std::move(line)), m_empty(false), m_line_num(line_num)
 {
-    static auto line_num = 0;
-    m_line_num = ++line_num;
 }
 
-void Line::split(const str& delimiter)
+void Line::split(const Splitter& splitter)
 {
-    auto pos_start = 0u;
-    auto pos_end = str::npos;
-
-    while((pos_end = m_line.find(delimiter,pos_start)) != str::npos) {
-        m_parts.push_back(m_line.substr(pos_start, (pos_end-pos_start)));
-        pos_start = pos_end + 1;
-    }
-    m_parts.push_back(m_line.substr(pos_start, (pos_end-pos_start)));
+    splitter.split(m_line, m_parts, m_owned);
 }
 
 std::string Line::getValue() const
@@ -77,99 +76,108 @@ unsigned Line::getNumParts() const
     return m_parts.size();
 }
 
-void Line::process(const Arguments& args)
+const char* Line::getPartData(unsigned part_num) const
 {
-    static const auto fields     = splitFields(args.get("-f"));
-    static const auto re_fields  = splitFields(args.get("-p"));
-    static const auto delimiter  = args.get("-d");
-    static const auto inverse    = args.get("-i");
-    static const auto re_search  = args.get("-xs");
-    static const auto re_replace = args.get("-xr");
+    const auto& part = m_parts[part_num];
+    return (part.owned < 0 ? m_line.data() : m_owned[part.owned].data()) + part.pos;
+}
 
+void Line::process(const LineConfig& config, ReplaceCache& cache)
+{
     // split the word
-    split(delimiter);
+    split(config.splitter);
 
     for (auto i = 0u; i<getNumParts(); ++i) {
         auto process = false;
 
-        if (re_search.empty()) {
+        if (!config.replace) {
             process = false;
-        } else if (re_fields.size() == 0) {
+        } else if (!config.fields.empty() && !config.fields.contains(i+1)) {
+            // not printed, so there is no need to replace it
+            process = false;
+        } else if (config.re_fields.empty()) {
             process = true;
-        } else if (find(i+1, re_fields)) {
-            process = (inverse == "0");
+        } else if (config.re_fields.contains(i+1)) {
+            process = !config.inverse;
         } else {
-            process = (inverse == "1");
+            process = config.inverse;
         }
 
         if (process) {
-            processPart(i, re_search, re_replace);
+            processPart(i, config, cache);
         }
     }
 
     // join requested fields and save string
-    m_line = join(delimiter, fields);
+    m_quote = config.csv;
+    join(config.delimiter, config.fields);
+    m_line.swap(m_joined);
+
+    // Fields are spans of the old line, which is not needed any more
+    m_parts.clear();
+    m_owned.clear();
+    m_joined.clear();
 }
 
-bool Line::find(unsigned needle, const uvec& haystack) const
-{
-    return std::find(haystack.begin(), haystack.end(), needle) != haystack.end();
-}
-
-void Line::processPart(int part_num, const str& re_search, const str& re_replace)
+void Line::processPart(int part_num, const LineConfig& config, ReplaceCache& cache)
 {
     try {
-        static const std::regex r(re_search);
-        m_parts[part_num] = std::regex_replace(m_parts[part_num], r, re_replace);
+        auto begin = getPartData(part_num);
+        auto size = m_parts[part_num].size;
+        auto replaced = std::string();
+
+        if (!cache.find(begin, size, replaced)) {
+            std::regex_replace(std::back_inserter(replaced), begin, begin + size, config.re_search, config.re_replace);
+            cache.insert(begin, size, replaced);
+        }
+        m_parts[part_num] = {0u, replaced.size(), static_cast<int>(m_owned.size())};
+        m_owned.push_back(std::move(replaced));
     } catch (...) {}
 }
 
 
-str Line::join(const str& delimiter, const uvec& fields)
+void Line::join(const str& delimiter, const FieldList& fields)
 {
+    m_joined.reserve(m_line.size());
 
-    if (fields.size() == 0) {
+    if (fields.empty()) {
         joinAll(delimiter);
     } else {
         joinList(delimiter, fields);
     }
-    return m_joined;
 }
 
-void Line::joinList(const str& delimiter, const uvec& fields)
+void Line::joinList(const str& delimiter, const FieldList& fields)
 {
     bool first = true;
-    for (auto i : fields) {
-        if (i<=getNumParts()) {
-            m_joined += first ? "" : delimiter;
-            m_joined += m_parts[i-1];
-            first = false;
+    fields.forEach(getNumParts(), [&](unsigned i) {
+        if (!first) {
+            m_joined += delimiter;
         }
-    }
+        appendPart(delimiter, i);
+        first = false;
+    });
 }
 
 void Line::joinAll(const str& delimiter)
 {
     for (auto i = 0u; i<getNumParts(); ++i) {
-        m_joined += (i == 0) ? "" : delimiter;
-        m_joined += m_parts[i];
+        if (i != 0) {
+            m_joined += delimiter;
+        }
+        appendPart(delimiter, i);
     }
 }
 
-std::vector<unsigned> Line::splitFields(const std::string& s) const
+void Line::appendPart(const str& delimiter, unsigned part_num)
 {
-    std::vector<unsigned> fields;
-
-    auto regex    = std::regex(",");
-    auto begin = std::sregex_token_iterator(s.begin(), s.end(), regex, -1);
-    auto end   = std::sregex_token_iterator();
-    std::for_each(begin, end, [&](const std::string& m) {
-        if (!m.empty()) {
-            fields.push_back(std::stoul(m));
-        }
-    });
-
-    return fields;
+    if (m_quote) {
+        CsvSplitter::appendField(m_joined, getPartData(part_num), m_parts[part_num].size, delimiter[0]);
+    } else {
+        m_joined.append(getPartData(part_num), m_parts[part_num].size);
+    }
 }
 
+} // namespace xcut
+
 #endif //JM_LINE_HPP
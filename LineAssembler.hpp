@@ -0,0 +1,121 @@
+#ifndef JM_LINE_ASSEMBLER_HPP
+#define JM_LINE_ASSEMBLER_HPP
+
+#include <cstring>
+#include <string>
+
+#include "Arguments.hpp"
+#include "Splitter.hpp"
+
+namespace xcut {
+
+// Assembles complete lines from buffers of any size, as they are read in
+// --follow mode or pushed to the Engine, keeping a trailing partial line for
+// the next buffer, or from lines already split by std::getline. With -q a line
+// is a CSV record, which continues past line breaks inside quoted fields and
+// may end in CRLF.
+//
+// Each complete line is handed to push as a std::string&, which may move it
+// away instead of copying it.
+class LineAssembler {
+public:
+    LineAssembler(const Arguments& args);
+    template <class Push> void add(const char* data, std::size_t size, Push push);
+    template <class Push> void addLine(std::string& line, Push push);
+    template <class Push> void finish(Push push);
+    void clear();
+
+private:
+    const bool m_csv;
+    const CsvSplitter m_csv_splitter;
+    std::string m_partial;
+    std::size_t m_line_start = 0u;  // of the last line in m_partial
+    bool m_open_record = false;     // before the last line in m_partial
+
+private:
+    template <class Push> void endLine(Push push);
+};
+
+LineAssembler::LineAssembler(const Arguments& args) :
+    m_csv(args.get("-q") == "1"), m_csv_splitter(args.get("-d"))
+{
+}
+
+template <class Push>
+void LineAssembler::add(const char* data, std::size_t size, Push push)
+{
+    auto start = data;
+    auto end   = data + size;
+    auto eol   = end;
+
+    while ((eol = static_cast<const char*>(memchr(start, '\n', end - start))) != nullptr) {
+        m_partial.append(start, eol - start);
+        endLine(push);
+        start = eol + 1;
+    }
+    m_partial.append(start, end - start);
+
+    return;
+}
+
+// Adds a line without its line break. Unless it continues a record, it is
+// taken over without copying, so it is left unspecified.
+template <class Push>
+void LineAssembler::addLine(std::string& line, Push push)
+{
+    if (m_partial.empty()) {
+        m_partial.swap(line);
+    } else {
+        m_partial += line;
+    }
+    endLine(push);
+
+    return;
+}
+
+// Hands over the trailing partial line, if any, as a complete line. A record
+// left open at the end of the input does not keep its last line break.
+template <class Push>
+void LineAssembler::finish(Push push)
+{
+    if (m_open_record && m_line_start == m_partial.size()) {
+        m_partial.pop_back();
+        if (!m_partial.empty() && m_partial.back() == '\r') {
+            m_partial.pop_back();
+        }
+    }
+    if (!m_partial.empty()) {
+        push(m_partial);
+    }
+    clear();
+
+    return;
+}
+
+template <class Push>
+void LineAssembler::endLine(Push push)
+{
+    auto carriage_return = m_csv && CsvSplitter::trimCarriageReturn(m_partial, m_line_start);
+    m_open_record = m_csv && m_csv_splitter.isRecordOpen(m_partial.data() + m_line_start,
+        m_partial.size() - m_line_start, m_open_record);
+    if (m_open_record) {
+        m_partial += carriage_return ? "\r\n" : "\n";
+        m_line_start = m_partial.size();
+    } else {
+        push(m_partial);
+        clear();
+    }
+
+    return;
+}
+
+void LineAssembler::clear()
+{
+    m_partial.clear();
+    m_line_start = 0u;
+    m_open_record = false;
+}
+
+} // namespace xcut
+
+#endif //JM_LINE_ASSEMBLER_HPP
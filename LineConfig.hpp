@@ -0,0 +1,46 @@
+#ifndef JM_LINE_CONFIG_HPP
+#define JM_LINE_CONFIG_HPP
+
+#include <regex>
+#include <string>
+
+#include "Arguments.hpp"
+#include "FieldList.hpp"
+#include "Regex.hpp"
+#include "Splitter.hpp"
+
+namespace xcut {
+
+// Settings to process lines, parsed once per pipeline from its arguments. It
+// is immutable, so all processors of a pipeline share it without locking, and
+// pipelines with different arguments can run side by side.
+struct LineConfig {
+    LineConfig(const Arguments& args);
+
+    const FieldList   fields;
+    const FieldList   re_fields;
+    const std::string delimiter;
+    const bool        inverse;
+    const bool        replace;
+    const std::regex  re_search;
+    const std::string re_replace;
+    const Splitter    splitter;
+    const bool        csv;
+};
+
+LineConfig::LineConfig(const Arguments& args) :
+    fields(args.get("-f")),
+    re_fields(args.get("-p")),
+    delimiter(args.get("-d")),
+    inverse(args.get("-i") == "1"),
+    replace(args.get("-xs") != "" && isRegex(args.get("-xs"))),
+    re_search(replace ? std::regex(args.get("-xs")) : std::regex()),
+    re_replace(args.get("-xr")),
+    splitter(args),
+    csv(args.get("-q") == "1")
+{
+}
+
+} // namespace xcut
+
+#endif //JM_LINE_CONFIG_HPP
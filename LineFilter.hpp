@@ -0,0 +1,265 @@
+#ifndef JM_LINE_FILTER_HPP
+#define JM_LINE_FILTER_HPP
+
+#include <cctype>
+#include <cstring>
+#include <regex>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Arguments.hpp"
+#include "Splitter.hpp"
+
+namespace xcut {
+
+// Finds a literal string. With SSE2, 16 candidate positions are checked at a
+// time by comparing both the first and the last character of the needle, and
+// only positions where both match are compared in full.
+class LiteralSearch {
+public:
+    LiteralSearch(const std::string& needle) : m_needle(needle) {}
+    bool empty() const;
+    bool isIn(const char* begin, const char* end) const;
+
+private:
+    std::string m_needle;
+};
+
+// Drops lines before they are queued, so they are never split, processed or
+// written. Lines are kept if PATTERN matches the whole line or the selected
+// field, or if it does not match when the filter is inverted.
+//
+// A literal that any match must contain is extracted from PATTERN and searched
+// first, which rejects most lines without running the regex. When PATTERN is
+// only a literal the regex is not run at all.
+class LineFilter {
+public:
+    LineFilter(const Arguments& args);
+    bool isActive() const;
+    bool accept(const std::string& line) const;
+    static std::string findRequiredLiteral(const std::string& pattern, bool& is_literal);
+
+private:
+    bool m_active;
+    bool m_invert;
+    unsigned m_field;
+    bool m_csv;
+    bool m_literal_only = false;
+    std::regex m_regex;
+    LiteralSearch m_literal;
+    Splitter m_splitter;
+
+private:
+    bool matches(const char* begin, const char* end) const;
+};
+
+bool LiteralSearch::empty() const
+{
+    return m_needle.empty();
+}
+
+bool LiteralSearch::isIn(const char* begin, const char* end) const
+{
+    const auto size = m_needle.size();
+    if (size == 0) {
+        return true;
+    } else if (static_cast<std::size_t>(end - begin) < size) {
+        return false;
+    }
+
+    auto pos = begin;
+
+#ifdef __SSE2__
+    const auto first = _mm_set1_epi8(m_needle.front());
+    const auto last  = _mm_set1_epi8(m_needle.back());
+
+    for (; pos + size - 1 + 16 <= end; pos += 16) {
+        auto block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        auto block_last  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos + size - 1));
+        auto mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                                                    _mm_cmpeq_epi8(block_last, last)));
+        while (mask != 0) {
+            auto bit = __builtin_ctz(mask);
+            if (memcmp(pos + bit, m_needle.data(), size) == 0) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Remaining positions, or all of them without SSE2
+    for (; pos + size <= end; ++pos) {
+        pos = static_cast<const char*>(memchr(pos, m_needle.front(), end - pos - size + 1));
+        if (pos == nullptr) {
+            return false;
+        } else if (memcmp(pos, m_needle.data(), size) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+LineFilter::LineFilter(const Arguments& args) :
+    m_active(args.get("-g") != ""),
+    m_invert(args.get("-v") == "1"),
+    m_field(args.get("-G") == "" ? 0u : std::stoul(args.get("-G"))),
+    m_csv(args.get("-q") == "1"),
+    m_literal(findRequiredLiteral(args.get("-g"), m_literal_only)),
+    m_splitter(args)
+{
+    if (m_active && !m_literal_only) {
+        m_regex = std::regex(args.get("-g"), std::regex::optimize);
+    }
+}
+
+bool LineFilter::isActive() const
+{
+    return m_active;
+}
+
+bool LineFilter::accept(const std::string& line) const
+{
+    if (!m_active) {
+        return true;
+    }
+
+    const auto begin = line.data();
+    const auto end   = begin + line.size();
+
+    // The prefilter on the whole line also holds for any of its fields, except
+    // for unescaped CSV fields, which can contain text the line does not.
+    if (!(m_csv && m_field != 0) && !m_literal.isIn(begin, end)) {
+        return m_invert;
+    } else if (m_field == 0) {
+        return matches(begin, end) != m_invert;
+    }
+
+    auto fields = Fields();
+    auto owned  = std::vector<std::string>();
+    m_splitter.split(line, fields, owned);
+    if (m_field > fields.size()) {
+        return m_invert;
+    }
+
+    const auto& field = fields[m_field - 1];
+    auto field_begin = (field.owned < 0 ? begin : owned[field.owned].data()) + field.pos;
+    auto field_end   = field_begin + field.size;
+    if (m_csv && !m_literal.isIn(field_begin, field_end)) {
+        return m_invert;
+    }
+
+    return matches(field_begin, field_end) != m_invert;
+}
+
+bool LineFilter::matches(const char* begin, const char* end) const
+{
+    if (m_literal_only) {
+        return m_literal.isIn(begin, end);
+    }
+
+    return std::regex_search(begin, end, m_regex);
+}
+
+// Returns the longest run of characters that every match of pattern contains,
+// or an empty string if none can be found safely. This is conservative: any
+// alternation gives up, and groups, classes and optional atoms end a run.
+// is_literal is set when pattern is the returned string and nothing else.
+std::string LineFilter::findRequiredLiteral(const std::string& pattern, bool& is_literal)
+{
+    auto best = std::string();
+    auto run  = std::string();
+    is_literal = !pattern.empty();
+
+    auto endRun = [&]() {
+        if (run.size() > best.size()) {
+            best = run;
+        }
+        run.clear();
+    };
+
+    // Moves i from a '[' to the ']' closing the class. A ']' right after '['
+    // or '[^' is part of it.
+    auto skipClass = [&pattern](unsigned& i) {
+        i += (i+1 < pattern.size() && pattern[i+1] == '^') ? 2 : 1;
+        for (i += (i < pattern.size() && pattern[i] == ']') ? 1 : 0; i<pattern.size() && pattern[i] != ']'; ++i) {
+            i += (pattern[i] == '\\') ? 1 : 0;
+        }
+    };
+
+    for (auto i = 0u; i<pattern.size(); ++i) {
+        auto c = pattern[i];
+        auto is_atom = false;
+
+        if (c == '|') {
+            is_literal = false;
+            return std::string();
+        } else if (c == '\\' && i+1 < pattern.size() && !isalnum(static_cast<unsigned char>(pattern[i+1]))) {
+            run += pattern[++i];
+            is_atom = true;
+        } else if (c == '[') {
+            skipClass(i);
+            is_literal = false;
+            endRun();
+        } else if (c == '(') {
+            // Skip the group, including nested groups and classes, which may
+            // contain parentheses
+            for (auto depth = 0; i<pattern.size(); ++i) {
+                if (pattern[i] == '\\') {
+                    ++i;
+                } else if (pattern[i] == '[') {
+                    skipClass(i);
+                } else if (pattern[i] == '(') {
+                    ++depth;
+                } else if (pattern[i] == ')' && --depth == 0) {
+                    break;
+                }
+            }
+            is_literal = false;
+            endRun();
+        } else if (c == '*' || c == '?' || c == '{') {
+            // The previous atom is optional, so it is not required
+            if (!run.empty()) {
+                run.pop_back();
+            }
+            if (c == '{') {
+                auto close = pattern.find('}', i);
+                i = (close == std::string::npos) ? pattern.size() : close;
+            }
+            is_literal = false;
+            endRun();
+        } else if (c == '+') {
+            is_literal = false;
+            endRun();
+        } else if (c == '\\' || c == '.' || c == '^' || c == '$') {
+            // Character classes like \d, anchors and back references. The
+            // operands of \xHH, \uHHHH and \cX are not literal either.
+            if (c == '\\' && ++i < pattern.size()) {
+                auto letter = pattern[i];
+                i += (letter == 'x') ? 2 : (letter == 'u') ? 4 : (letter == 'c') ? 1 : 0;
+            }
+            is_literal = false;
+            endRun();
+        } else {
+            run += c;
+            is_atom = true;
+        }
+
+        // An atom followed by + is required, but what follows is not adjacent
+        if (is_atom && i+1 < pattern.size() && pattern[i+1] == '+') {
+            endRun();
+        }
+    }
+    endRun();
+
+    return best;
+}
+
+} // namespace xcut
+
+#endif //JM_LINE_FILTER_HPP
@@ -0,0 +1,229 @@
+#ifndef JM_LINE_INDEX_HPP
+#define JM_LINE_INDEX_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xcut {
+
+// Sidecar index of line offsets, stored next to a file as FILE.xcutidx. It
+// holds the line count and the byte offset of every m_stride-th line, so that
+// reading from any line seeks close to it instead of scanning the file from
+// the start. The index is only used while the file size and modification time
+// match the ones recorded in it.
+class LineIndex {
+public:
+    LineIndex(const std::string& file_name);
+    bool load();
+    bool build();
+    std::uint64_t findOffset(std::uint64_t line, std::uint64_t& offset_line) const;
+    std::uint64_t getLineCount() const;
+    static std::string getPath(const std::string& file_name);
+
+private:
+    const std::string m_file_name;
+    const char m_magic[8] = {'X', 'C', 'U', 'T', 'I', 'D', 'X', '1'};
+    std::uint64_t m_size       = 0u;
+    std::uint64_t m_mtime_sec  = 0u;
+    std::uint64_t m_mtime_nsec = 0u;
+    std::uint64_t m_line_count = 0u;
+    std::uint64_t m_stride     = 1024u;
+    std::vector<std::uint64_t> m_offsets;
+
+private:
+    bool readFileStatus(std::uint64_t& size, std::uint64_t& mtime_sec, std::uint64_t& mtime_nsec) const;
+    bool save() const;
+};
+
+LineIndex::LineIndex(const std::string& file_name) : m_file_name(file_name)
+{
+}
+
+std::string LineIndex::getPath(const std::string& file_name)
+{
+    return file_name + ".xcutidx";
+}
+
+bool LineIndex::readFileStatus(std::uint64_t& size, std::uint64_t& mtime_sec, std::uint64_t& mtime_nsec) const
+{
+    struct stat buf;
+    if (stat(m_file_name.c_str(), &buf) != 0) {
+        return false;
+    }
+
+    size       = buf.st_size;
+    mtime_sec  = buf.st_mtim.tv_sec;
+    mtime_nsec = buf.st_mtim.tv_nsec;
+
+    return true;
+}
+
+// Header values are only kept once they are all valid, so that a corrupt
+// index cannot leave a bad stride for build(), nor make load() allocate more
+// offsets than the file can have lines. Offsets must start at 0, increase and
+// fall inside the file.
+bool LineIndex::load()
+{
+    std::ifstream in(getPath(m_file_name), std::ifstream::binary);
+
+    char magic[sizeof(m_magic)];
+    std::uint64_t size        = 0u;
+    std::uint64_t mtime_sec   = 0u;
+    std::uint64_t mtime_nsec  = 0u;
+    std::uint64_t line_count  = 0u;
+    std::uint64_t stride      = 0u;
+    std::uint64_t num_offsets = 0u;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&size), sizeof(size));
+    in.read(reinterpret_cast<char*>(&mtime_sec), sizeof(mtime_sec));
+    in.read(reinterpret_cast<char*>(&mtime_nsec), sizeof(mtime_nsec));
+    in.read(reinterpret_cast<char*>(&line_count), sizeof(line_count));
+    in.read(reinterpret_cast<char*>(&stride), sizeof(stride));
+    in.read(reinterpret_cast<char*>(&num_offsets), sizeof(num_offsets));
+
+    auto file_size = std::uint64_t(0);
+    auto file_mtime_sec = std::uint64_t(0);
+    auto file_mtime_nsec = std::uint64_t(0);
+
+    // Every line takes at least one byte, so there are no more lines than bytes
+    if (!in || memcmp(magic, m_magic, sizeof(m_magic)) != 0
+            || !readFileStatus(file_size, file_mtime_sec, file_mtime_nsec)
+            || size != file_size || mtime_sec != file_mtime_sec || mtime_nsec != file_mtime_nsec
+            || stride == 0 || line_count > file_size
+            || num_offsets != line_count / stride + (line_count % stride != 0 ? 1 : 0)) {
+        return false;
+    }
+
+    auto offsets = std::vector<std::uint64_t>(num_offsets);
+    in.read(reinterpret_cast<char*>(offsets.data()), num_offsets * sizeof(std::uint64_t));
+    if (!in || (!offsets.empty() && offsets[0] != 0)) {
+        return false;
+    }
+    for (auto i = 0u; i<offsets.size(); ++i) {
+        if (offsets[i] >= size || (i > 0 && offsets[i] <= offsets[i-1])) {
+            return false;
+        }
+    }
+
+    m_size       = size;
+    m_mtime_sec  = mtime_sec;
+    m_mtime_nsec = mtime_nsec;
+    m_line_count = line_count;
+    m_stride     = stride;
+    m_offsets.swap(offsets);
+
+    return true;
+}
+
+// Scans the whole file for line breaks, then saves the index. A failure to
+// save is reported, but the index built in memory can still be used.
+bool LineIndex::build()
+{
+    if (!readFileStatus(m_size, m_mtime_sec, m_mtime_nsec)) {
+        return false;
+    }
+
+    auto fd = open(m_file_name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    m_offsets.clear();
+    m_line_count = 0u;
+
+    auto buffer = std::vector<char>(1u << 20);
+    auto offset = std::uint64_t(0);
+    auto line_start = true;
+    auto count = ssize_t(0);
+
+    while ((count = read(fd, buffer.data(), buffer.size())) > 0) {
+        auto start = buffer.data();
+        auto end   = start + count;
+
+        while (start < end) {
+            if (line_start) {
+                if (m_line_count % m_stride == 0) {
+                    m_offsets.push_back(offset + (start - buffer.data()));
+                }
+                ++m_line_count;
+                line_start = false;
+            }
+
+            auto eol = static_cast<const char*>(memchr(start, '\n', end - start));
+            if (eol == nullptr) {
+                break;
+            }
+            start = const_cast<char*>(eol) + 1;
+            line_start = true;
+        }
+        offset += count;
+    }
+    close(fd);
+
+    if (count < 0) {
+        return false;
+    } else if (!save()) {
+        std::cerr << "xcut: cannot write index " << getPath(m_file_name) << "." << std::endl;
+    }
+
+    return true;
+}
+
+// Writes to a temporary file first, so other runs never read half an index
+bool LineIndex::save() const
+{
+    auto path = getPath(m_file_name);
+    auto temp_path = path + "." + std::to_string(getpid());
+    std::uint64_t num_offsets = m_offsets.size();
+
+    {
+        std::ofstream out(temp_path, std::ofstream::binary | std::ofstream::trunc);
+        out.write(m_magic, sizeof(m_magic));
+        out.write(reinterpret_cast<const char*>(&m_size), sizeof(m_size));
+        out.write(reinterpret_cast<const char*>(&m_mtime_sec), sizeof(m_mtime_sec));
+        out.write(reinterpret_cast<const char*>(&m_mtime_nsec), sizeof(m_mtime_nsec));
+        out.write(reinterpret_cast<const char*>(&m_line_count), sizeof(m_line_count));
+        out.write(reinterpret_cast<const char*>(&m_stride), sizeof(m_stride));
+        out.write(reinterpret_cast<const char*>(&num_offsets), sizeof(num_offsets));
+        out.write(reinterpret_cast<const char*>(m_offsets.data()), num_offsets * sizeof(std::uint64_t));
+        if (!out) {
+            out.close();
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+    return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+// Returns the offset of the closest indexed line at or before line (1-index
+// based), and sets offset_line to that line's number.
+std::uint64_t LineIndex::findOffset(std::uint64_t line, std::uint64_t& offset_line) const
+{
+    if (m_offsets.empty() || line <= 1) {
+        offset_line = 1u;
+        return 0u;
+    }
+
+    auto slot = std::min<std::uint64_t>((line - 1) / m_stride, m_offsets.size() - 1);
+    offset_line = slot * m_stride + 1;
+
+    return m_offsets[slot];
+}
+
+std::uint64_t LineIndex::getLineCount() const
+{
+    return m_line_count;
+}
+
+} // namespace xcut
+
+#endif //JM_LINE_INDEX_HPP
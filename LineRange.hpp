@@ -0,0 +1,69 @@
+#ifndef JM_LINE_RANGE_HPP
+#define JM_LINE_RANGE_HPP
+
+#include <cstdint>
+#include <regex>
+#include <stdexcept>
+#include <string>
+
+namespace xcut {
+
+// Range of 1-index based lines given as N, N-M, N- or -M. Line numbers are
+// 64-bit, as files can hold more than 2^32 lines. A last line of 0 means the
+// range is open-ended, and so does an empty range.
+class LineRange {
+public:
+    LineRange(const std::string& range);
+    std::uint64_t getFirst() const;
+    std::uint64_t getLast() const;
+    static bool validate(const std::string& range);
+
+private:
+    std::uint64_t m_first = 1u;
+    std::uint64_t m_last  = 0u;
+};
+
+LineRange::LineRange(const std::string& range)
+{
+    if (range.empty()) {
+        return;
+    }
+
+    auto dash = range.find('-');
+    m_first = (dash == 0) ? 1u : std::stoull(range.substr(0, dash));
+    m_last  = m_first;
+    if (dash != std::string::npos) {
+        m_last = (dash+1 < range.size()) ? std::stoull(range.substr(dash+1)) : 0u;
+    }
+}
+
+std::uint64_t LineRange::getFirst() const
+{
+    return m_first;
+}
+
+std::uint64_t LineRange::getLast() const
+{
+    return m_last;
+}
+
+bool LineRange::validate(const std::string& range)
+{
+    auto regex = std::regex("^([1-9]\\d*(-([1-9]\\d*)?)?|-[1-9]\\d*)$");
+    if (range == "") {
+        return true;
+    } else if (!std::regex_match(range, regex)) {
+        return false;
+    }
+
+    try {
+        auto parsed = LineRange(range);
+        return parsed.m_last == 0 || parsed.m_last >= parsed.m_first;
+    } catch (const std::out_of_range&) {
+        return false;
+    }
+}
+
+} // namespace xcut
+
+#endif //JM_LINE_RANGE_HPP
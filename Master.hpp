@@ -9,10 +9,13 @@
 #include "DataQueue.hpp"
 #include "DataReader.hpp"
 #include "DataWriter.hpp"
+#include "LineConfig.hpp"
 
+namespace xcut {
 
 class Master {
 private:
+    const LineConfig m_line_config;
     DataQueue m_queue_in;
     DataQueue m_queue_out;
     std::vector<std::shared_ptr<Worker>> m_workers;
@@ -25,6 +28,7 @@ public:
     Master(const Arguments& args);
     void startWorkers();
     bool workersDone();
+    bool workersFailed() const;
 
 private:
     void checkStatus();
@@ -33,8 +37,9 @@ private:
 };
 
 Master::Master(const Arguments& args) :
+    m_line_config(args),
     m_num_reading_workers(1),
-    m_num_process_workers(std::max(std::thread::hardware_concurrency() -2, 1u)),
+    m_num_process_workers(std::max(std::thread::hardware_concurrency(), 3u) - 2),
     m_num_writing_workers(1)
 {
 
@@ -43,7 +48,7 @@ Master::Master(const Arguments& args) :
 
     // Spawn Processors
     for (auto i = 0u; i<m_num_process_workers; ++i) {
-        m_workers.push_back(std::make_shared<DataProcessor>(args, m_queue_in, m_queue_out));
+        m_workers.push_back(std::make_shared<DataProcessor>(args, m_line_config, m_queue_in, m_queue_out));
     }
 
     // Spawn Writer
@@ -66,9 +71,9 @@ void Master::notifyWorkers()
 
 void Master::checkStatus()
 {
-    static const auto expected_reading    = m_num_reading_workers;
-    static const auto expected_processing = expected_reading    + m_num_process_workers;
-    static const auto expected_writing    = expected_processing + m_num_writing_workers;
+    const auto expected_reading    = m_num_reading_workers;
+    const auto expected_processing = expected_reading    + m_num_process_workers;
+    const auto expected_writing    = expected_processing + m_num_writing_workers;
 
     // Workers are not "done" until the workers that feed them with data are done.
     auto done_count = std::count_if(m_workers.begin(), m_workers.end(), [](std::shared_ptr<Worker>& w){return w->done();});
@@ -94,4 +99,11 @@ bool Master::workersDone()
     return m_status == Status::done;
 }
 
+bool Master::workersFailed() const
+{
+    return std::any_of(m_workers.begin(), m_workers.end(), [](const std::shared_ptr<Worker>& w){return w->failed();});
+}
+
+} // namespace xcut
+
 #endif //JM_MASTER_HPP
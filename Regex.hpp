@@ -0,0 +1,23 @@
+#ifndef JM_REGEX_HPP
+#define JM_REGEX_HPP
+
+#include <regex>
+#include <string>
+
+namespace xcut {
+
+// Tells whether pattern compiles as a std::regex
+bool isRegex(const std::string& pattern)
+{
+    try {
+        std::regex regex(pattern);
+    } catch (const std::regex_error&) {
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace xcut
+
+#endif //JM_REGEX_HPP
@@ -0,0 +1,140 @@
+#ifndef JM_REPLACE_CACHE_HPP
+#define JM_REPLACE_CACHE_HPP
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Arguments.hpp"
+
+namespace xcut {
+
+// Direct-mapped cache of regex replacement results, keyed by field content.
+// Each processor owns one, so it needs no locking. Low-cardinality fields
+// (hosts, status codes, levels) then skip most regex evaluations.
+//
+// An adaptive cache turns itself off if its hit rate over the first lookups is
+// too low to pay for hashing and copying the keys. That is the default (-m
+// auto), with m_auto_slots slots.
+class ReplaceCache {
+public:
+    ReplaceCache(const Arguments& args);
+    bool find(const char* key, std::size_t size, std::string& value);
+    void insert(const char* key, std::size_t size, const std::string& value);
+    bool isEnabled() const;
+    unsigned long getHits() const;
+    unsigned long getMisses() const;
+
+private:
+    struct Entry {
+        bool used = false;
+        std::string key;
+        std::string value;
+    };
+
+    std::vector<Entry> m_entries;
+    std::size_t m_mask = 0u;
+    bool m_enabled;
+    bool m_adaptive;
+    unsigned long m_hits   = 0u;
+    unsigned long m_misses = 0u;
+    const std::size_t m_max_key_size = 256u;
+    const unsigned long m_sample_size = 8192u;
+    static const unsigned m_auto_slots = 4096u;
+
+private:
+    Entry& getEntry(const char* key, std::size_t size);
+    void adapt();
+};
+
+ReplaceCache::ReplaceCache(const Arguments& args) :
+    m_adaptive(args.get("-m") == "auto")
+{
+    auto slots = m_adaptive ? m_auto_slots : std::stoul(args.get("-m"));
+    m_enabled = slots > 0;
+
+    // Round up to a power of two so the slot is a mask of the hash
+    auto size = std::size_t(1);
+    while (size < slots) {
+        size <<= 1;
+    }
+
+    if (m_enabled) {
+        m_entries.resize(size);
+        m_mask = size - 1;
+    }
+}
+
+// Copies the cached value of key into value. The copy is made before adapt(),
+// which may free the entries.
+bool ReplaceCache::find(const char* key, std::size_t size, std::string& value)
+{
+    if (!m_enabled || size > m_max_key_size) {
+        return false;
+    }
+
+    const auto& entry = getEntry(key, size);
+    auto found = entry.used && entry.key.size() == size && memcmp(entry.key.data(), key, size) == 0;
+    if (found) {
+        value = entry.value;
+        ++m_hits;
+    } else {
+        ++m_misses;
+    }
+    adapt();
+
+    return found;
+}
+
+void ReplaceCache::insert(const char* key, std::size_t size, const std::string& value)
+{
+    if (!m_enabled || size > m_max_key_size) {
+        return;
+    }
+
+    auto& entry = getEntry(key, size);
+    entry.used = true;
+    entry.key.assign(key, size);
+    entry.value = value;
+}
+
+bool ReplaceCache::isEnabled() const
+{
+    return m_enabled;
+}
+
+unsigned long ReplaceCache::getHits() const
+{
+    return m_hits;
+}
+
+unsigned long ReplaceCache::getMisses() const
+{
+    return m_misses;
+}
+
+ReplaceCache::Entry& ReplaceCache::getEntry(const char* key, std::size_t size)
+{
+    // FNV-1a
+    auto hash = std::size_t(14695981039346656037ull);
+    for (auto c = key; c != key + size; ++c) {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * std::size_t(1099511628211ull);
+    }
+
+    return m_entries[hash & m_mask];
+}
+
+void ReplaceCache::adapt()
+{
+    if (m_adaptive && m_hits + m_misses == m_sample_size) {
+        m_adaptive = false;
+        if (m_hits < m_sample_size / 4) {
+            m_enabled = false;
+            m_entries = std::vector<Entry>();
+        }
+    }
+}
+
+} // namespace xcut
+
+#endif //JM_REPLACE_CACHE_HPP
@@ -0,0 +1,372 @@
+#ifndef JM_SPLITTER_HPP
+#define JM_SPLITTER_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Arguments.hpp"
+#include "FieldList.hpp"
+
+namespace xcut {
+
+// A field is a span of the line, or of a string owned by the line once the
+// field has been unescaped or rewritten. Keeping spans avoids copying fields
+// that are output unchanged.
+struct Field {
+    std::size_t pos;
+    std::size_t size;
+    int owned;      // index of the owned string, or -1 for the line itself
+};
+
+typedef std::vector<Field> Fields;
+
+// Finds a single character delimiter. memchr is vectorised by the C library.
+class CharSearch {
+public:
+    CharSearch(const std::string& delimiter) : m_delimiter(delimiter[0]) {}
+    std::size_t find(const std::string& line, std::size_t pos) const;
+    std::size_t size() const { return 1u; }
+
+private:
+    char m_delimiter;
+};
+
+// Finds a multi-character delimiter using Boyer-Moore-Horspool, with the skip
+// table computed once for the whole run.
+class SubstringSearch {
+public:
+    SubstringSearch(const std::string& delimiter);
+    std::size_t find(const std::string& line, std::size_t pos) const;
+    std::size_t size() const { return m_delimiter.size(); }
+
+private:
+    std::string m_delimiter;
+    std::size_t m_skip[256];
+};
+
+// Splits a line into the text between delimiters found by Search
+template <class Search>
+class DelimiterSplitter {
+public:
+    DelimiterSplitter(const std::string& delimiter) : m_search(delimiter) {}
+    void split(const std::string& line, Fields& fields) const;
+
+private:
+    Search m_search;
+};
+
+// Splits RFC 4180 CSV, where fields may be quoted to contain the delimiter,
+// quotes (escaped by doubling them) or line breaks. Lines without quotes take
+// the plain delimiter path. Otherwise a table-driven state machine runs on the
+// delimiter and quote characters only, and the text between them is copied in
+// bulk. Stray quotes are kept as text, as most CSV readers do.
+class CsvSplitter {
+public:
+    CsvSplitter(const std::string& delimiter);
+    void split(const std::string& line, Fields& fields, std::vector<std::string>& owned) const;
+    static void appendField(std::string& out, const char* part, std::size_t size, char delimiter);
+    bool isRecordOpen(const char* part, std::size_t size, bool open) const;
+    static bool trimCarriageReturn(std::string& line, std::size_t line_start);
+
+private:
+    enum State  {start, unquoted, quoted, quote_seen, num_states};
+    enum Class  {text, delimiter, quote_char, num_classes};
+    enum Action {none, append, end_field};
+    struct Transition {
+        State  next;
+        Action action;
+    };
+    static const Transition m_table[num_states][num_classes];
+    char m_delimiter;
+    DelimiterSplitter<CharSearch> m_plain;
+
+private:
+    std::size_t findSpecial(const std::string& line, std::size_t pos, State state) const;
+};
+
+// Columns counted in bytes, as in cut -b
+struct ByteUnit {
+    static std::size_t offset(const std::string& line, unsigned column);
+};
+
+// Columns counted in UTF-8 characters, as in cut -c
+struct Utf8Unit {
+    static std::size_t offset(const std::string& line, unsigned column);
+};
+
+// Splits a line into fixed-width fields, one per column range. An open-ended
+// range goes up to the end of the line.
+template <class Unit>
+class ColumnSplitter {
+public:
+    ColumnSplitter(const std::string& list) : m_ranges(FieldList(list).ranges()) {}
+    void split(const std::string& line, Fields& fields) const;
+
+private:
+    FieldList::Ranges m_ranges;
+};
+
+// Picks the splitter matching the arguments once, so that per line there is a
+// single switch and the splitting loop itself is specialised for its mode.
+class Splitter {
+public:
+    Splitter(const Arguments& args);
+    void split(const std::string& line, Fields& fields, std::vector<std::string>& owned) const;
+
+private:
+    enum class Mode {character, substring, csv, bytes, utf8};
+    Mode m_mode;
+    DelimiterSplitter<CharSearch> m_char_splitter;
+    DelimiterSplitter<SubstringSearch> m_substring_splitter;
+    CsvSplitter m_csv_splitter;
+    ColumnSplitter<ByteUnit> m_byte_splitter;
+    ColumnSplitter<Utf8Unit> m_utf8_splitter;
+};
+
+std::size_t CharSearch::find(const std::string& line, std::size_t pos) const
+{
+    auto found = static_cast<const char*>(memchr(line.data() + pos, m_delimiter, line.size() - pos));
+    return found ? found - line.data() : std::string::npos;
+}
+
+SubstringSearch::SubstringSearch(const std::string& delimiter) : m_delimiter(delimiter)
+{
+    for (auto& skip : m_skip) {
+        skip = m_delimiter.size();
+    }
+    for (auto i = 0u; i+1 < m_delimiter.size(); ++i) {
+        m_skip[static_cast<unsigned char>(m_delimiter[i])] = m_delimiter.size() - 1 - i;
+    }
+}
+
+std::size_t SubstringSearch::find(const std::string& line, std::size_t pos) const
+{
+    const auto size = m_delimiter.size();
+    const auto last = size - 1;
+
+    while (pos + size <= line.size()) {
+        auto c = static_cast<unsigned char>(line[pos + last]);
+        if (c == static_cast<unsigned char>(m_delimiter[last])
+                && memcmp(line.data() + pos, m_delimiter.data(), last) == 0) {
+            return pos;
+        }
+        pos += m_skip[c];
+    }
+
+    return std::string::npos;
+}
+
+template <class Search>
+void DelimiterSplitter<Search>::split(const std::string& line, Fields& fields) const
+{
+    auto pos_start = std::size_t(0);
+    auto pos_end = std::string::npos;
+
+    while((pos_end = m_search.find(line, pos_start)) != std::string::npos) {
+        fields.push_back({pos_start, pos_end - pos_start, -1});
+        pos_start = pos_end + m_search.size();
+    }
+    fields.push_back({pos_start, line.size() - pos_start, -1});
+}
+
+const CsvSplitter::Transition CsvSplitter::m_table[num_states][num_classes] = {
+    //  text                   delimiter            quote_char
+    {{unquoted, append}, {start, end_field}, {quoted, none}},       // start
+    {{unquoted, append}, {start, end_field}, {unquoted, append}},   // unquoted
+    {{quoted, append},   {quoted, append},   {quote_seen, none}},   // quoted
+    {{unquoted, append}, {start, end_field}, {quoted, append}},     // quote_seen
+};
+
+CsvSplitter::CsvSplitter(const std::string& delimiter) :
+    m_delimiter(delimiter[0]), m_plain(delimiter)
+{
+}
+
+void CsvSplitter::split(const std::string& line, Fields& fields, std::vector<std::string>& owned) const
+{
+    if (memchr(line.data(), '"', line.size()) == nullptr) {
+        m_plain.split(line, fields);
+        return;
+    }
+
+    // Fields that never were inside quotes are the same as in the line, so
+    // only the unescaped text of quoted fields is accumulated.
+    auto state   = start;
+    auto field   = std::string();
+    auto escaped = false;
+    auto begin   = std::size_t(0);
+    auto pos     = std::size_t(0);
+
+    auto endField = [&](std::size_t end) {
+        if (escaped) {
+            fields.push_back({0u, field.size(), static_cast<int>(owned.size())});
+            owned.push_back(std::move(field));
+        } else {
+            fields.push_back({begin, end - begin, -1});
+        }
+        field.clear();
+        escaped = false;
+        begin = end + 1;
+    };
+
+    while (pos < line.size()) {
+        // Text never changes the state of unquoted or quoted fields
+        if (state == unquoted || state == quoted) {
+            auto special = findSpecial(line, pos, state);
+            if (escaped) {
+                field.append(line, pos, special - pos);
+            }
+            pos = special;
+            if (pos == line.size()) {
+                break;
+            }
+        }
+
+        auto c = line[pos++];
+        auto type = (c == '"') ? quote_char : (c == m_delimiter) ? delimiter : text;
+        const auto& transition = m_table[state][type];
+
+        if (transition.action == append && escaped) {
+            field += c;
+        } else if (transition.action == end_field) {
+            endField(pos - 1);
+        }
+        escaped = escaped || transition.next == quoted;
+        state = transition.next;
+    }
+    endField(line.size());
+}
+
+std::size_t CsvSplitter::findSpecial(const std::string& line, std::size_t pos, State state) const
+{
+    auto end = line.data() + line.size();
+    auto quote_pos = static_cast<const char*>(memchr(line.data() + pos, '"', line.size() - pos));
+    if (state == unquoted) {
+        auto limit = quote_pos ? quote_pos : end;
+        auto delim_pos = static_cast<const char*>(memchr(line.data() + pos, m_delimiter, limit - line.data() - pos));
+        quote_pos = delim_pos ? delim_pos : quote_pos;
+    }
+
+    return (quote_pos ? quote_pos : end) - line.data();
+}
+
+// A record with an unterminated quoted field continues on the next line. part
+// is one line of the record, and open tells whether the record was still open
+// before it, so each line is scanned once and by the same rules as split().
+bool CsvSplitter::isRecordOpen(const char* part, std::size_t size, bool open) const
+{
+    if (!open && memchr(part, '"', size) == nullptr) {
+        return false;
+    }
+
+    auto state = open ? quoted : start;
+    for (auto c = part; c != part + size; ++c) {
+        auto type = (*c == '"') ? quote_char : (*c == m_delimiter) ? delimiter : text;
+        state = m_table[state][type].next;
+    }
+
+    return state == quoted;
+}
+
+// Records may end in CRLF. Removes the \r before the line break from the last
+// line of line, which starts at line_start, and tells whether there was one.
+// The caller puts it back if the record turns out to be still open, as then
+// the \r belongs to a quoted field.
+bool CsvSplitter::trimCarriageReturn(std::string& line, std::size_t line_start)
+{
+    if (line.size() > line_start && line.back() == '\r') {
+        line.pop_back();
+        return true;
+    }
+
+    return false;
+}
+
+// Appends a field to out, quoted only if it contains the delimiter, quotes or
+// line breaks.
+void CsvSplitter::appendField(std::string& out, const char* part, std::size_t size, char delimiter)
+{
+    auto end = part + size;
+    auto needs_quotes = std::any_of(part, end, [delimiter](char c) {
+        return c == delimiter || c == '"' || c == '\n' || c == '\r';
+    });
+
+    if (!needs_quotes) {
+        out.append(part, size);
+        return;
+    }
+
+    out += '"';
+    for (auto c = part; c != end; ++c) {
+        out += *c;
+        if (*c == '"') {
+            out += '"';
+        }
+    }
+    out += '"';
+}
+
+std::size_t ByteUnit::offset(const std::string& line, unsigned column)
+{
+    return std::min<std::size_t>(column, line.size());
+}
+
+std::size_t Utf8Unit::offset(const std::string& line, unsigned column)
+{
+    auto pos = std::size_t(0);
+    for (; pos < line.size(); ++pos) {
+        // Continuation bytes (10xxxxxx) do not start a new character
+        if ((line[pos] & 0xC0) != 0x80 && column-- == 0) {
+            break;
+        }
+    }
+
+    return pos;
+}
+
+template <class Unit>
+void ColumnSplitter<Unit>::split(const std::string& line, Fields& fields) const
+{
+    for (const auto& range : m_ranges) {
+        auto begin = Unit::offset(line, range.first - 1);
+        auto end   = range.second == 0 ? line.size() : Unit::offset(line, range.second);
+        fields.push_back({begin, end - begin, -1});
+    }
+}
+
+Splitter::Splitter(const Arguments& args) :
+    m_char_splitter(args.get("-d")),
+    m_substring_splitter(args.get("-d")),
+    m_csv_splitter(args.get("-d")),
+    m_byte_splitter(args.get("-b")),
+    m_utf8_splitter(args.get("-c"))
+{
+    if (args.get("-b") != "") {
+        m_mode = Mode::bytes;
+    } else if (args.get("-c") != "") {
+        m_mode = Mode::utf8;
+    } else if (args.get("-q") == "1") {
+        m_mode = Mode::csv;
+    } else if (args.get("-d").size() == 1) {
+        m_mode = Mode::character;
+    } else {
+        m_mode = Mode::substring;
+    }
+}
+
+void Splitter::split(const std::string& line, Fields& fields, std::vector<std::string>& owned) const
+{
+    switch (m_mode) {
+        case Mode::character: m_char_splitter.split(line, fields);        break;
+        case Mode::substring: m_substring_splitter.split(line, fields);   break;
+        case Mode::csv:       m_csv_splitter.split(line, fields, owned);  break;
+        case Mode::bytes:     m_byte_splitter.split(line, fields);        break;
+        case Mode::utf8:      m_utf8_splitter.split(line, fields);        break;
+    }
+}
+
+} // namespace xcut
+
+#endif //JM_SPLITTER_HPP
@@ -2,14 +2,18 @@
 #define JM_WORKER_HPP
 
 #include <atomic>
+#include <chrono>
 #include <thread>
 
+namespace xcut {
+
 enum class Status {reading, processing, writing, done};
 
 class Worker {
 public:
     virtual void start();
     virtual bool done() const;
+    virtual bool failed() const;
     Worker(const Arguments& args);
     virtual void update(const Status& status);
     virtual ~Worker();
@@ -17,8 +21,10 @@ public:
 protected:
     std::thread m_thread;
     std::atomic<bool> m_done{false};
+    std::atomic<bool> m_failed{false};
     std::atomic<Status> m_status{Status::reading};
     const Arguments& m_args;
+    const std::chrono::milliseconds m_idle_wait{10};
 
 protected:
     virtual void doJob() = 0;
@@ -39,6 +45,11 @@ bool Worker::done() const
     return m_done;
 }
 
+bool Worker::failed() const
+{
+    return m_failed;
+}
+
 void Worker::start()
 {
     m_thread = std::thread(&Worker::doJob, this);
@@ -51,4 +62,6 @@ Worker::~Worker()
     }
 }
 
+} // namespace xcut
+
 #endif //JM_WORKER_HPP
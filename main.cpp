@@ -1,9 +1,13 @@
+#include <chrono>
+#include <thread>
+
 #include "ArgManager.hpp"
 #include "Master.hpp"
 
 int main(int argc, char **argv)
 {
-    ArgManager arg_manager;
+    xcut::ArgManager arg_manager;
+    auto status = 0;
 
     if (!arg_manager.processArgs(argc, argv)) {
         arg_manager.showHelp();
@@ -12,12 +16,15 @@ int main(int argc, char **argv)
     } else {
         auto args = arg_manager.getArgs();
 
-        Master master(args);
+        xcut::Master master(args);
         master.startWorkers();
 
-        while(!master.workersDone());
+        while(!master.workersDone()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        status = master.workersFailed() ? 1 : 0;
     }
 
-    return 0;
+    return status;
 }
 
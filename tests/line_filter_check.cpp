@@ -0,0 +1,59 @@
+// Regression check for the literal prefilter of -g: it must never drop a line
+// that the regex matches. Each line is filtered by the Engine and compared
+// with std::regex_search on the text the regex runs on, which is the line or
+// the unescaped -G field. Built with AddressSanitizer by make check.
+
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "Engine.hpp"
+
+struct Case {
+    std::vector<std::string> options;
+    std::string pattern;
+    std::vector<std::string> lines;
+    std::vector<std::string> subjects;  // the line itself if empty
+};
+
+int main()
+{
+    const auto cases = std::vector<Case>({
+        {{}, "([)])abc", {")abc", "]abc", "abc", "x)abc"}, {}},
+        {{}, "(x|[)])abc", {"xabc", ")abc", "yabc", "abc"}, {}},
+        {{}, "\\x41", {"A", "x41", "a"}, {}},
+        {{}, "[]a]bc", {"]bc", "abc", "xbc"}, {}},
+        {{}, "a+bc", {"aabc", "bc", "abc"}, {}},
+        {{}, "abc", {"xabcx", "ab", "abd"}, {}},
+        {{"-q", "-d", ",", "-G", "2"}, "a\"b", {"x,\"a\"\"b\"", "x,ab", "a\"\"b,y"}, {"a\"b", "ab", "y"}},
+    });
+
+    auto status = 0;
+    for (const auto& test : cases) {
+        auto options = test.options;
+        options.push_back("-g");
+        options.push_back(test.pattern);
+
+        auto input = std::string();
+        auto expected = std::string();
+        auto regex = std::regex(test.pattern);
+        for (auto i = 0u; i<test.lines.size(); ++i) {
+            const auto& subject = test.subjects.empty() ? test.lines[i] : test.subjects[i];
+            input += test.lines[i] + "\n";
+            if (std::regex_search(subject, regex)) {
+                expected += test.lines[i] + "\n";
+            }
+        }
+
+        xcut::Engine engine(options);
+        auto output = engine.push(input.data(), input.size());
+        output += engine.finish();
+        if (output != expected) {
+            std::cerr << "line_filter_check: unexpected output for -g '" << test.pattern << "'" << std::endl;
+            status = 1;
+        }
+    }
+
+    return status;
+}
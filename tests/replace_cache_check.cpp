@@ -0,0 +1,33 @@
+// Regression check for the replace cache turning itself off on a hit: the
+// 8192nd lookup below is a hit that disables the cache, and its value must
+// still be used. Built with AddressSanitizer by make check.
+
+#include <iostream>
+#include <string>
+
+#include "Engine.hpp"
+
+int main()
+{
+    xcut::Engine engine({"-x", "s/a/b/"});
+    auto input  = std::string();
+    auto expected = std::string();
+
+    for (auto i = 0u; i<7191u; ++i) {
+        input += "u" + std::to_string(i) + "\n";
+        expected += "u" + std::to_string(i) + "\n";
+    }
+    for (auto i = 0u; i<1001u; ++i) {
+        input += "xa\n";
+        expected += "xb\n";
+    }
+
+    auto output = engine.push(input.data(), input.size());
+    output += engine.finish();
+    if (output != expected) {
+        std::cerr << "replace_cache_check: unexpected output" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}